@@ -0,0 +1,73 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CombatEventBus.h"
+#include "DarkSouls_Boss_Fight.h"
+#include "Engine/World.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+
+DECLARE_CYCLE_STAT(TEXT("Combat Event Drain"), STAT_CombatEventDrain, STATGROUP_Combat);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Combat Events"), STAT_CombatEventCount, STATGROUP_Combat);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Combat Events Dropped"), STAT_CombatEventDropped, STATGROUP_Combat);
+
+CSV_DEFINE_CATEGORY(Combat, true);
+
+bool UCombatEventBus::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UCombatEventBus::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UCombatEventBus, STATGROUP_Tickables);
+}
+
+void UCombatEventBus::Push(const FCombatEvent& Event)
+{
+	if (!Ring.Push(Event))
+	{
+		DroppedEvents.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+void UCombatEventBus::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+	SCOPE_CYCLE_COUNTER(STAT_CombatEventDrain);
+
+	FrameEvents.Reset();
+	FCombatEvent Event;
+	while (Ring.Pop(Event))
+	{
+		FrameEvents.Add(Event);
+	}
+
+	const auto Dropped = DroppedEvents.exchange(0, std::memory_order_relaxed);
+	SET_DWORD_STAT(STAT_CombatEventCount, FrameEvents.Num());
+	SET_DWORD_STAT(STAT_CombatEventDropped, Dropped);
+	if (Dropped > 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Combat event ring overflowed, %d events dropped this frame"), Dropped);
+	}
+
+#if CSV_PROFILER
+	// telemetry: per-type counts for csvprofile captures
+	int32 TypeCounts[static_cast<int32>(ECombatEventType::Count)] = {};
+	for (const auto& FrameEvent : FrameEvents)
+	{
+		++TypeCounts[static_cast<int32>(FrameEvent.Type)];
+	}
+	CSV_CUSTOM_STAT(Combat, HitLanded, TypeCounts[static_cast<int32>(ECombatEventType::HitLanded)], ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(Combat, StumbleStarted, TypeCounts[static_cast<int32>(ECombatEventType::StumbleStarted)], ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(Combat, AttackStarted, TypeCounts[static_cast<int32>(ECombatEventType::AttackStarted)], ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(Combat, StateChanged, TypeCounts[static_cast<int32>(ECombatEventType::StateChanged)], ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(Combat, RollStarted, TypeCounts[static_cast<int32>(ECombatEventType::RollStarted)], ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(Combat, RollEnded, TypeCounts[static_cast<int32>(ECombatEventType::RollEnded)], ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(Combat, EventsDropped, Dropped, ECsvCustomStatOp::Set);
+#endif
+
+	if (FrameEvents.Num() > 0)
+	{
+		OnEventsDrained.Broadcast(FrameEvents);
+	}
+}
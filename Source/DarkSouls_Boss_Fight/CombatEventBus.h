@@ -0,0 +1,42 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "CombatEvents.h"
+#include "CombatEventBus.generated.h"
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnCombatEventsDrained, TArrayView<const FCombatEvent> /*Events*/);
+
+/**
+ * Gameplay code pushes combat events from any thread, consumers (camera shake, audio,
+ * UI, telemetry) receive them once per frame as a single batch after all actors ticked.
+ */
+UCLASS()
+class DARKSOULS_BOSS_FIGHT_API UCombatEventBus : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	// lock-free, never allocates; drops the event if the frame overflows the ring
+	void Push(const FCombatEvent& Event);
+
+	FOnCombatEventsDrained OnEventsDrained;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	static constexpr uint32 RingCapacity = 1024;
+
+	TCombatEventRing<FCombatEvent, RingCapacity> Ring;
+
+	// reused every frame
+	TArray<FCombatEvent> FrameEvents;
+
+	std::atomic<int32> DroppedEvents{ 0 };
+};
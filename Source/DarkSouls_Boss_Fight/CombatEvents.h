@@ -0,0 +1,108 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/WeakObjectPtr.h"
+#include <atomic>
+
+enum class ECombatEventType : uint8
+{
+	HitLanded,				// Source's weapon damaged Other
+	StumbleStarted,			// Source got interrupted by Other
+	AttackStarted,			// Source started an attack
+	StateChanged,			// Source's state machine moved from OldState to NewState
+	RollStarted,
+	RollEnded,
+
+	Count
+};
+
+struct FCombatEvent
+{
+	ECombatEventType Type = ECombatEventType::HitLanded;
+	TWeakObjectPtr<AActor> Source;
+	TWeakObjectPtr<AActor> Other;
+	FVector Location = FVector::ZeroVector;
+	float Amount = 0.f;
+	uint8 OldState = 0;
+	uint8 NewState = 0;
+	double TimeSeconds = 0.;
+};
+
+/**
+ * Bounded multi-producer single-consumer ring buffer.
+ * Push is lock-free and never allocates, it fails when the ring is full.
+ * Pop must only ever be called from one thread.
+ */
+template<typename ElementType, uint32 Capacity>
+class TCombatEventRing
+{
+	static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+	TCombatEventRing()
+	{
+		for (uint32 Index = 0; Index < Capacity; ++Index)
+		{
+			Slots[Index].Sequence.store(Index, std::memory_order_relaxed);
+		}
+	}
+
+	bool Push(const ElementType& Element)
+	{
+		auto Position = Head.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			auto& Slot = Slots[Position & (Capacity - 1)];
+			const auto Sequence = Slot.Sequence.load(std::memory_order_acquire);
+			const auto Difference = static_cast<int32>(Sequence - Position);
+			if (Difference == 0)
+			{
+				// slot is free for this position, claim it
+				if (Head.compare_exchange_weak(Position, Position + 1, std::memory_order_relaxed))
+				{
+					Slot.Element = Element;
+					Slot.Sequence.store(Position + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (Difference < 0)
+			{
+				// consumer has not freed this slot yet: full
+				return false;
+			}
+			else
+			{
+				Position = Head.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	bool Pop(ElementType& OutElement)
+	{
+		auto& Slot = Slots[Tail & (Capacity - 1)];
+		const auto Sequence = Slot.Sequence.load(std::memory_order_acquire);
+		if (static_cast<int32>(Sequence - (Tail + 1)) < 0)
+		{
+			return false;
+		}
+
+		OutElement = Slot.Element;
+		Slot.Sequence.store(Tail + Capacity, std::memory_order_release);
+		++Tail;
+		return true;
+	}
+
+private:
+	struct FSlot
+	{
+		std::atomic<uint32> Sequence;
+		ElementType Element;
+	};
+
+	FSlot Slots[Capacity];
+
+	alignas(PLATFORM_CACHE_LINE_SIZE) std::atomic<uint32> Head{ 0 };
+	alignas(PLATFORM_CACHE_LINE_SIZE) uint32 Tail = 0;
+};
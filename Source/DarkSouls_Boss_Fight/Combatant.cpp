@@ -2,6 +2,8 @@
 
 
 #include "Combatant.h"
+#include "CombatantTickSubsystem.h"
+#include "CombatEventBus.h"
 #include "GameFramework/CharacterMovementComponent.h"
 
 // Sets default values
@@ -11,14 +13,82 @@ ACombatant::ACombatant()
 	PrimaryActorTick.bCanEverTick = true;
 }
 
-// Called every frame
-void ACombatant::Tick(float DeltaTime)
+void ACombatant::BeginPlay()
 {
-	Super::Tick(DeltaTime);
+	Super::BeginPlay();
 
-	if (bRotateTowardsTarget)
+	// decisions are computed in a batch over all combatants, committed before our own tick
+	if (const auto TickSubsystem = GetWorld()->GetSubsystem<UCombatantTickSubsystem>())
 	{
-		LookAtSmooth();
+		TickSubsystem->RegisterCombatant(this);
+	}
+
+	EventBus = GetWorld()->GetSubsystem<UCombatEventBus>();
+
+	if (const auto HitFeedbackSubsystem = GetWorld()->GetSubsystem<UHitFeedbackSubsystem>())
+	{
+		HitFeedbackSubsystem->Prewarm(HitFeedback);
+	}
+}
+
+void ACombatant::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (const auto TickSubsystem = GetWorld()->GetSubsystem<UCombatantTickSubsystem>())
+	{
+		TickSubsystem->UnregisterCombatant(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void ACombatant::GatherSnapshot(FCombatantSnapshot& Snapshot) const
+{
+	Snapshot.Compute = &ACombatant::ComputeDecision;
+
+	Snapshot.Location = GetActorLocation();
+	Snapshot.Forward = GetActorForwardVector();
+	Snapshot.Rotation = GetActorRotation();
+
+	Snapshot.bHasTarget = Target != nullptr;
+	Snapshot.TargetLocation = Target ? Target->GetActorLocation() : FVector::ZeroVector;
+
+	Snapshot.DeltaSeconds = GetWorld()->GetDeltaSeconds();
+	Snapshot.TimeSeconds = GetWorld()->GetTimeSeconds();
+	Snapshot.RotationSmoothing = RotationSmoothing;
+
+	Snapshot.bCanRotate = bRotateTowardsTarget && Target && bTargetLocked && !bAttacking &&
+		!GetCharacterMovement()->IsFalling();
+
+	Snapshot.bAttacking = bAttacking;
+	Snapshot.bAttackDamaging = bAttackDamaging;
+	Snapshot.bMovingForward = bMovingForward;
+	Snapshot.bMovingBackwards = bMovingBackwards;
+	Snapshot.bStumbling = bStumbling;
+}
+
+void ACombatant::ComputeDecision(const FCombatantSnapshot& Snapshot, FCombatantDecision& Decision)
+{
+	if (Snapshot.bCanRotate)
+	{
+		auto Direction = Snapshot.TargetLocation - Snapshot.Location;
+		Direction.Z = 0.f;
+		const auto Rotation = FRotationMatrix::MakeFromX(Direction).Rotator();
+		Decision.Rotation = FMath::Lerp(Snapshot.Rotation, Rotation, Snapshot.RotationSmoothing * Snapshot.DeltaSeconds);
+		Decision.bApplyRotation = true;
+	}
+}
+
+bool ACombatant::IsSnapshotCurrent(const FCombatantSnapshot& Snapshot) const
+{
+	return Snapshot.bAttacking == bAttacking && Snapshot.bStumbling == bStumbling;
+}
+
+void ACombatant::CommitDecision(const FCombatantDecision& Decision)
+{
+	if (Decision.bApplyRotation)
+	{
+		LastRotationSpeed = Decision.Rotation.Yaw - GetActorRotation().Yaw;
+		SetActorRotation(Decision.Rotation);
 	}
 }
 
@@ -29,6 +99,26 @@ void ACombatant::SetupPlayerInputComponent(UInputComponent* PlayerInputComponent
 
 }
 
+void ACombatant::PushCombatEvent(ECombatEventType Type, AActor* Other, float Amount)
+{
+	if (!EventBus) return;
+
+	FCombatEvent Event;
+	Event.Type = Type;
+	Event.Source = this;
+	Event.Other = Other;
+	Event.Location = Other ? Other->GetActorLocation() : GetActorLocation();
+	Event.Amount = Amount;
+	Event.TimeSeconds = GetWorld()->GetTimeSeconds();
+	EventBus->Push(Event);
+}
+
+void ACombatant::GetWarmupMontages(TArray<UAnimMontage*>& OutMontages) const
+{
+	OutMontages.Append(AttackAnimations);
+	OutMontages.Append(TakeHit_StumbleBackwards);
+}
+
 void ACombatant::Attack()
 {
 	bAttacking = true;
@@ -36,6 +126,7 @@ void ACombatant::Attack()
 	bAttackDamaging = false;
 
 	AttackHitActors.Empty();
+	PushCombatEvent(ECombatEventType::AttackStarted, Target);
 }
 
 void ACombatant::AttackLunge()
@@ -83,20 +174,6 @@ void ACombatant::AttackNextReady()
 	bNextAttackReady = true;
 }
 
-void ACombatant::LookAtSmooth()
-{
-	if (Target && bTargetLocked && !bAttacking &&
-		!GetCharacterMovement()->IsFalling())
-	{
-		auto Direction = Target->GetActorLocation() - GetActorLocation();
-		Direction.Z = 0.f;
-		const auto Rotation = FRotationMatrix::MakeFromX(Direction).Rotator();
-		const auto SmoothedRotation = FMath::Lerp(GetActorRotation(), Rotation, RotationSmoothing * GetWorld()->GetDeltaSeconds());
-		LastRotationSpeed = SmoothedRotation.Yaw - GetActorRotation().Yaw;
-		SetActorRotation(SmoothedRotation);
-	}
-}
-
 float ACombatant::GetCurrentRotationSpeed()
 {
 	//!TODO Always bRotateTowardsTarget = true
@@ -4,8 +4,92 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
+#include "CombatEvents.h"
+#include "HitFeedbackSubsystem.h"
 #include "Combatant.generated.h"
 
+
+UENUM(BlueprintType)
+enum class State : uint8
+{
+	IDLE,					// Outside of combat
+	CHASE_CLOSE,			// Combat, staying close to target
+	CHASE_FAR,				// Combat, doesn't care about range
+	ATTACK,					// In the process of attacking
+	STUMBLE,				// Stumbling from being damaged/interrupted
+	TAUNT,					// Emoting during a fight
+	DEAD					// Dead
+};
+
+// Side effect requested by the compute phase, carried out in the commit phase
+enum class ECombatantAction : uint8
+{
+	None,
+	Attack,					// Start a regular attack
+	LongAttack,				// Start a long range attack if the target is visible
+	MoveToTarget,			// Path towards the target
+	MoveForward,			// Step forward during an attack
+	StepBack				// Step back during a stumble
+};
+
+struct FCombatantSnapshot;
+struct FCombatantDecision;
+
+// Pure per-frame decision function, run on worker threads. It only sees the snapshot
+// and only writes the decision, so it cannot touch actors or the world.
+typedef void (*FCombatantComputeFn)(const FCombatantSnapshot& Snapshot, FCombatantDecision& Decision);
+
+// Read-only copy of everything the compute phase needs, gathered on the game thread
+struct FCombatantSnapshot
+{
+	FCombatantComputeFn Compute = nullptr;
+
+	FVector Location = FVector::ZeroVector;
+	FVector Forward = FVector::ForwardVector;
+	FRotator Rotation = FRotator::ZeroRotator;
+
+	bool bHasTarget = false;
+	FVector TargetLocation = FVector::ZeroVector;
+
+	float DeltaSeconds = 0.f;
+	float TimeSeconds = 0.f;
+	float RotationSmoothing = 0.f;
+
+	// target locked, not attacking, not falling and allowed to turn
+	bool bCanRotate = false;
+
+	bool bAttacking = false;
+	bool bAttackDamaging = false;
+	bool bMovingForward = false;
+	bool bMovingBackwards = false;
+	bool bStumbling = false;
+
+	State ActiveState = State::IDLE;
+
+	// time at which a long range attack is off cooldown
+	float LongAttackReadyTime = 0.f;
+
+	float AggroDistance = 0.f;
+	float EncounterPrepareDistance = 0.f;
+};
+
+// Result of the compute phase, applied on the game thread
+struct FCombatantDecision
+{
+	bool bApplyRotation = false;
+	FRotator Rotation = FRotator::ZeroRotator;
+
+	bool bLockTarget = false;
+	bool bPrepareEncounter = false;
+
+	// only set for an actual transition, NewState is meaningless otherwise
+	bool bChangeState = false;
+	State NewState = State::IDLE;
+
+	ECombatantAction Action = ECombatantAction::None;
+	bool bApplyWeaponDamage = false;
+};
+
 UCLASS()
 class DARKSOULS_BOSS_FIGHT_API ACombatant : public ACharacter
 {
@@ -13,12 +97,37 @@ class DARKSOULS_BOSS_FIGHT_API ACombatant : public ACharacter
 
 public:
 	ACombatant();
-	virtual void Tick(float DeltaTime) override;
 	virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
 
+	// game thread: copy the state the compute phase needs
+	virtual void GatherSnapshot(FCombatantSnapshot& Snapshot) const;
+
+	// any thread: turn a snapshot into a decision
+	static void ComputeDecision(const FCombatantSnapshot& Snapshot, FCombatantDecision& Decision);
+
+	// game thread: false if an earlier commit this frame (a hit, a stumble) changed
+	// what the snapshot was taken from, the decision is dropped then
+	virtual bool IsSnapshotCurrent(const FCombatantSnapshot& Snapshot) const;
+
+	// game thread: apply transforms, montages and damage
+	virtual void CommitDecision(const FCombatantDecision& Decision);
+
+	const FHitFeedback& GetHitFeedback() const { return HitFeedback; }
+
+	// montages played offscreen before an encounter so their first use doesn't hitch
+	virtual void GetWarmupMontages(TArray<UAnimMontage*>& OutMontages) const;
+
 protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 	AActor* Target;
 
+	class UCombatEventBus* EventBus = nullptr;
+
+	// queue a combat event for this frame's consumers
+	void PushCombatEvent(ECombatEventType Type, AActor* Other = nullptr, float Amount = 0.f);
+
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Combat")
 		bool bTargetLocked = false;
 
@@ -40,6 +149,10 @@ protected:
 	UPROPERTY(EditAnywhere, Category = "Animations")
 		TArray<UAnimMontage*> TakeHit_StumbleBackwards;
 
+	// sparks, sound and camera shake for hits this combatant lands
+	UPROPERTY(EditAnywhere, Category = "Combat")
+		FHitFeedback HitFeedback;
+
 	// Actors hit with the last attack - Used to stop duplicate hits
 	TArray<AActor*> AttackHitActors;
 
@@ -73,8 +186,6 @@ protected:
 	UFUNCTION(BlueprintCallable, Category = "Combat")
 		virtual void AttackNextReady();
 
-	virtual void LookAtSmooth();
-
 	// anim called: get rate of actors look rotation
 	UFUNCTION(BlueprintCallable, Category = "Animation")
 		float GetCurrentRotationSpeed();
@@ -0,0 +1,236 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CombatantTickSubsystem.h"
+#include "DarkSouls_Boss_Fight.h"
+#include "EnemyBase.h"
+#include "Async/ParallelFor.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Engine/Level.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_CYCLE_STAT(TEXT("Combatant Gather"), STAT_CombatantGather, STATGROUP_Combat);
+DECLARE_CYCLE_STAT(TEXT("Combatant Compute"), STAT_CombatantCompute, STATGROUP_Combat);
+DECLARE_CYCLE_STAT(TEXT("Combatant Commit"), STAT_CombatantCommit, STATGROUP_Combat);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Combatants"), STAT_CombatantCount, STATGROUP_Combat);
+
+static TAutoConsoleVariable<int32> CVarCombatParallelTick(
+	TEXT("Combat.ParallelTick"),
+	1,
+	TEXT("Compute combatant decisions on worker threads.\n")
+	TEXT("0: game thread only, 1: parallel (default)"));
+
+// a decision costs a few tens of nanoseconds, waking workers for a handful of enemies
+// costs more than it saves. The default has not been measured on multi-core hardware,
+// it only keeps tiny fights serial; set it from Combat.BenchmarkCompute's crossover
+static TAutoConsoleVariable<int32> CVarCombatParallelTickMinCombatants(
+	TEXT("Combat.ParallelTick.MinCombatants"),
+	256,
+	TEXT("Compute decisions on the game thread below this many combatants.\n")
+	TEXT("The default is provisional and unmeasured, tune it from the crossover Combat.BenchmarkCompute reports on target hardware."));
+
+// smaller batches cost more in scheduling than they save
+static constexpr int32 ComputeMinBatchSize = 32;
+
+void FCombatantBatchTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType,
+	ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (Owner)
+	{
+		Owner->TickCombatants(DeltaTime);
+	}
+}
+
+FString FCombatantBatchTickFunction::DiagnosticMessage()
+{
+	return TEXT("FCombatantBatchTickFunction");
+}
+
+bool UCombatantTickSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UCombatantTickSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	// commit has to land before combatants tick and before movement consumes their input
+	BatchTickFunction.Owner = this;
+	BatchTickFunction.bCanEverTick = true;
+	BatchTickFunction.bStartWithTickEnabled = true;
+	BatchTickFunction.bRunOnAnyThread = false;
+	BatchTickFunction.TickGroup = TG_PrePhysics;
+	BatchTickFunction.RegisterTickFunction(InWorld.PersistentLevel);
+}
+
+void UCombatantTickSubsystem::Deinitialize()
+{
+	if (BatchTickFunction.IsTickFunctionRegistered())
+	{
+		BatchTickFunction.UnRegisterTickFunction();
+	}
+	BatchTickFunction.Owner = nullptr;
+
+	Combatants.Empty();
+	Snapshots.Empty();
+	Decisions.Empty();
+
+	Super::Deinitialize();
+}
+
+void UCombatantTickSubsystem::RegisterCombatant(ACombatant* Combatant)
+{
+	check(IsInGameThread());
+	if (Combatant && !Combatants.Contains(Combatant))
+	{
+		Combatants.Add(Combatant);
+		Combatant->PrimaryActorTick.AddPrerequisite(this, BatchTickFunction);
+	}
+}
+
+void UCombatantTickSubsystem::UnregisterCombatant(ACombatant* Combatant)
+{
+	check(IsInGameThread());
+	const auto Index = Combatants.Find(Combatant);
+	if (Index == INDEX_NONE) return;
+
+	Combatant->PrimaryActorTick.RemovePrerequisite(this, BatchTickFunction);
+
+	// slots are matched by index during a tick, so only clear it and compact afterwards
+	Combatants[Index] = nullptr;
+}
+
+void UCombatantTickSubsystem::TickCombatants(float DeltaTime)
+{
+	check(IsInGameThread());
+
+	Combatants.RemoveAllSwap([](const ACombatant* Combatant) { return Combatant == nullptr; });
+
+	const auto Num = Combatants.Num();
+	SET_DWORD_STAT(STAT_CombatantCount, Num);
+	if (Num == 0) return;
+
+	// gather: game thread, read only
+	{
+		SCOPE_CYCLE_COUNTER(STAT_CombatantGather);
+		Snapshots.SetNum(Num, false);
+		for (int32 Index = 0; Index < Num; ++Index)
+		{
+			Snapshots[Index] = FCombatantSnapshot();
+			Combatants[Index]->GatherSnapshot(Snapshots[Index]);
+		}
+	}
+
+	// compute: worker threads, snapshot in, decision out
+	{
+		SCOPE_CYCLE_COUNTER(STAT_CombatantCompute);
+		const auto bParallel = CVarCombatParallelTick.GetValueOnGameThread() != 0 &&
+			Num >= CVarCombatParallelTickMinCombatants.GetValueOnGameThread();
+		ComputeDecisions(Snapshots, Decisions, bParallel);
+	}
+
+	// commit: game thread, side effects only happen here
+	{
+		SCOPE_CYCLE_COUNTER(STAT_CombatantCommit);
+		for (int32 Index = 0; Index < Num; ++Index)
+		{
+			// earlier commits can hit or stagger this combatant, its decision is stale then
+			const auto Combatant = Combatants[Index];
+			if (Combatant && Combatant->IsSnapshotCurrent(Snapshots[Index]))
+			{
+				Combatant->CommitDecision(Decisions[Index]);
+			}
+		}
+	}
+}
+
+void UCombatantTickSubsystem::ComputeDecisions(const TArray<FCombatantSnapshot>& InSnapshots,
+	TArray<FCombatantDecision>& OutDecisions, bool bParallel)
+{
+	const auto Num = InSnapshots.Num();
+	OutDecisions.SetNum(Num, false);
+
+	ParallelFor(TEXT("CombatantCompute"), Num, ComputeMinBatchSize, [&InSnapshots, &OutDecisions](int32 Index)
+	{
+		const auto& Snapshot = InSnapshots[Index];
+		auto& Decision = OutDecisions[Index];
+		Decision = FCombatantDecision();
+		if (Snapshot.Compute)
+		{
+			Snapshot.Compute(Snapshot, Decision);
+		}
+	}, bParallel ? EParallelForFlags::None : EParallelForFlags::ForceSingleThread);
+}
+
+// Combat.BenchmarkCompute [Combatants] [Iterations]
+// Times the compute phase over synthetic enemies, game thread only vs parallel, for the
+// given count and for a sweep of counts to find where parallel starts to pay off.
+static FAutoConsoleCommand CombatBenchmarkComputeCommand(
+	TEXT("Combat.BenchmarkCompute"),
+	TEXT("Times the combatant compute phase serial vs parallel. Args: [Combatants=500] [Iterations=200]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const auto RequestedNum = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 500;
+		const auto Iterations = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 200;
+
+		TArray<FCombatantSnapshot> BenchSnapshots;
+		TArray<FCombatantDecision> BenchDecisions;
+		auto Setup = [&BenchSnapshots](int32 Num)
+		{
+			BenchSnapshots.SetNum(Num);
+			for (int32 Index = 0; Index < Num; ++Index)
+			{
+				auto& Snapshot = BenchSnapshots[Index];
+				Snapshot = FCombatantSnapshot();
+				Snapshot.Compute = &AEnemyBase::ComputeDecision;
+				Snapshot.Location = FVector(FMath::FRandRange(-5000.f, 5000.f), FMath::FRandRange(-5000.f, 5000.f), 0.f);
+				Snapshot.Rotation = FRotator(0.f, FMath::FRandRange(-180.f, 180.f), 0.f);
+				Snapshot.Forward = Snapshot.Rotation.Vector();
+				Snapshot.bHasTarget = true;
+				Snapshot.TargetLocation = FVector::ZeroVector;
+				Snapshot.DeltaSeconds = 1.f / 60.f;
+				Snapshot.RotationSmoothing = 5.f;
+				Snapshot.bCanRotate = true;
+				Snapshot.ActiveState = static_cast<State>(Index % static_cast<int32>(State::TAUNT));
+			}
+		};
+		auto RunPass = [&](bool bParallel)
+		{
+			const auto StartTime = FPlatformTime::Seconds();
+			for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+			{
+				UCombatantTickSubsystem::ComputeDecisions(BenchSnapshots, BenchDecisions, bParallel);
+			}
+			return (FPlatformTime::Seconds() - StartTime) * 1000. / Iterations;
+		};
+		auto Measure = [&](int32 Num, double& OutSerialMs, double& OutParallelMs)
+		{
+			Setup(Num);
+			// warm up the task graph workers before timing
+			RunPass(true);
+			OutSerialMs = RunPass(false);
+			OutParallelMs = RunPass(true);
+		};
+
+		double SerialMs, ParallelMs;
+		Measure(RequestedNum, SerialMs, ParallelMs);
+		UE_LOG(LogTemp, Display, TEXT("Combat.BenchmarkCompute: %d combatants, %d workers: serial %.4f ms (%.1f ns per combatant), parallel %.4f ms, speedup %.2fx"),
+			RequestedNum, FTaskGraphInterface::Get().GetNumWorkerThreads(), SerialMs, SerialMs * 1000000. / RequestedNum,
+			ParallelMs, ParallelMs > 0. ? SerialMs / ParallelMs : 0.);
+
+		int32 Crossover = INDEX_NONE;
+		for (int32 Num = 64; Num <= 16384; Num *= 2)
+		{
+			Measure(Num, SerialMs, ParallelMs);
+			UE_LOG(LogTemp, Display, TEXT("  %5d combatants: serial %.4f ms, parallel %.4f ms, speedup %.2fx"),
+				Num, SerialMs, ParallelMs, ParallelMs > 0. ? SerialMs / ParallelMs : 0.);
+			if (Crossover == INDEX_NONE && ParallelMs < SerialMs)
+			{
+				Crossover = Num;
+			}
+		}
+		UE_LOG(LogTemp, Display, TEXT("Combat.BenchmarkCompute: parallel first wins at %d combatants, Combat.ParallelTick.MinCombatants is %d"),
+			Crossover, CVarCombatParallelTickMinCombatants.GetValueOnGameThread());
+	}));
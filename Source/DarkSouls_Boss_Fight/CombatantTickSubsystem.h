@@ -0,0 +1,71 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineBaseTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Combatant.h"
+#include "CombatantTickSubsystem.generated.h"
+
+class UCombatantTickSubsystem;
+
+USTRUCT()
+struct FCombatantBatchTickFunction : public FTickFunction
+{
+	GENERATED_BODY()
+
+	UCombatantTickSubsystem* Owner = nullptr;
+
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread,
+		const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+};
+
+template<>
+struct TStructOpsTypeTraits<FCombatantBatchTickFunction> : public TStructOpsTypeTraitsBase2<FCombatantBatchTickFunction>
+{
+	enum
+	{
+		WithCopy = false
+	};
+};
+
+/**
+ * Ticks every combatant's decision logic as one batch, before any combatant's own Tick:
+ * gather snapshots on the game thread, compute decisions (on worker threads once there are
+ * enough combatants to pay for it), then commit them on the game thread.
+ */
+UCLASS()
+class DARKSOULS_BOSS_FIGHT_API UCombatantTickSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+
+	void RegisterCombatant(ACombatant* Combatant);
+	void UnregisterCombatant(ACombatant* Combatant);
+
+	void TickCombatants(float DeltaTime);
+
+	FTickFunction& GetTickFunction() { return BatchTickFunction; }
+
+	// runs the compute phase over the given snapshots, in parallel unless told otherwise
+	static void ComputeDecisions(const TArray<FCombatantSnapshot>& InSnapshots,
+		TArray<FCombatantDecision>& OutDecisions, bool bParallel);
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	UPROPERTY(Transient)
+		TArray<ACombatant*> Combatants;
+
+	// reused every frame, indexed like Combatants
+	TArray<FCombatantSnapshot> Snapshots;
+	TArray<FCombatantDecision> Decisions;
+
+	FCombatantBatchTickFunction BatchTickFunction;
+};
@@ -10,7 +10,7 @@ public class DarkSouls_Boss_Fight : ModuleRules
 
         PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject",
             "Engine", "InputCore", "HeadMountedDisplay",
-            "AIModule", "GameplayCameras" });
+            "AIModule", "GameplayCameras", "Niagara" });
 
         PrivateDependencyModuleNames.AddRange(new string[] {  });
 
@@ -0,0 +1,295 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "EncounterPreparationSubsystem.h"
+#include "DarkSouls_Boss_Fight.h"
+#include "EnemyBoss.h"
+#include "Animation/AnimMontage.h"
+#include "Animation/AnimSingleNodeInstance.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/AssetManager.h"
+#include "Engine/StreamableManager.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/App.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Encounter Hitches"), STAT_EncounterHitches, STATGROUP_Combat);
+
+CSV_DECLARE_CATEGORY_EXTERN(Combat);
+
+// how far below the world origin warmup proxies play
+static constexpr float WarmupProxyDepth = 100000.f;
+
+static TAutoConsoleVariable<int32> CVarEncounterPrewarm(
+	TEXT("Combat.Encounter.Prewarm"),
+	1,
+	TEXT("Prepare encounters (asset streaming, PSO precache, montage warmup) before enemies aggro."));
+
+static TAutoConsoleVariable<float> CVarEncounterHitchThresholdMs(
+	TEXT("Combat.Encounter.HitchThresholdMs"),
+	50.f,
+	TEXT("Frames longer than this count as hitches while an encounter is tracked."));
+
+static TAutoConsoleVariable<float> CVarEncounterHitchWindow(
+	TEXT("Combat.Encounter.HitchWindow"),
+	15.f,
+	TEXT("Seconds after aggro during which hitches are counted."));
+
+bool UEncounterPreparationSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UEncounterPreparationSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UEncounterPreparationSubsystem, STATGROUP_Tickables);
+}
+
+void UEncounterPreparationSubsystem::Deinitialize()
+{
+	for (auto& Pair : Encounters)
+	{
+		if (Pair.Value.LoadHandle.IsValid())
+		{
+			Pair.Value.LoadHandle->CancelHandle();
+		}
+	}
+	Encounters.Empty();
+
+	if (ProxyOwner)
+	{
+		ProxyOwner->Destroy();
+		ProxyOwner = nullptr;
+	}
+	Warmups.Empty();
+
+	Super::Deinitialize();
+}
+
+void UEncounterPreparationSubsystem::PrepareEncounter(AEnemyBase* Enemy, ACombatant* Opponent)
+{
+	if (!Enemy || CVarEncounterPrewarm.GetValueOnGameThread() == 0) return;
+	if (Encounters.Contains(Enemy)) return;
+
+	auto& Preparation = Encounters.Add(Enemy);
+	Preparation.Enemy = Enemy;
+	Preparation.StartTime = FPlatformTime::Seconds();
+
+	// assets only the fight needs (arena VFX, music, ...) are soft references
+	TArray<FSoftObjectPath> AssetPaths;
+	for (const auto& Asset : Enemy->EncounterAssets)
+	{
+		if (!Asset.IsNull())
+		{
+			AssetPaths.Add(Asset.ToSoftObjectPath());
+		}
+	}
+	if (AssetPaths.Num() > 0)
+	{
+		Preparation.LoadHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(AssetPaths,
+			FStreamableDelegate(), FStreamableManager::AsyncLoadHighPriority);
+	}
+
+	// the opponent is usually the player, shared by every encounter: only the first one
+	// pays for it
+	for (ACombatant* Combatant : { static_cast<ACombatant*>(Enemy), Opponent })
+	{
+		if (!Combatant) continue;
+
+		PrecacheCombatant(Combatant);
+		AddMontageWarmup(Combatant);
+	}
+}
+
+void UEncounterPreparationSubsystem::PrecacheCombatant(ACombatant* Combatant)
+{
+	// materials of the body, weapon and anything else the fighter renders
+	TArray<UPrimitiveComponent*> Primitives;
+	Combatant->GetComponents(Primitives);
+
+	TArray<UMaterialInterface*> Materials;
+	for (const auto Primitive : Primitives)
+	{
+		UObject* Asset = nullptr;
+		if (const auto StaticMeshComponent = Cast<UStaticMeshComponent>(Primitive))
+		{
+			Asset = StaticMeshComponent->GetStaticMesh();
+		}
+		else if (const auto SkinnedMeshComponent = Cast<USkinnedMeshComponent>(Primitive))
+		{
+			Asset = SkinnedMeshComponent->GetSkinnedAsset();
+		}
+
+		auto Key = HashCombine(GetTypeHash(Primitive->GetClass()), GetTypeHash(Asset));
+		Materials.Reset();
+		Primitive->GetUsedMaterials(Materials);
+		for (const auto Material : Materials)
+		{
+			Key = HashCombine(Key, GetTypeHash(Material));
+		}
+
+		bool bAlreadyPrecached = false;
+		PrecachedPrimitives.Add(Key, &bAlreadyPrecached);
+		if (!bAlreadyPrecached)
+		{
+			Primitive->PrecachePSOs();
+		}
+	}
+}
+
+void UEncounterPreparationSubsystem::AddMontageWarmup(ACombatant* Combatant)
+{
+	const auto SourceMesh = Combatant->GetMesh();
+	const auto SkeletalMesh = SourceMesh ? SourceMesh->GetSkeletalMeshAsset() : nullptr;
+	if (!SkeletalMesh) return;
+
+	TArray<UAnimMontage*> Montages;
+	Combatant->GetWarmupMontages(Montages);
+
+	// minions of the same kind share mesh and montages, only the first one gets a proxy
+	FMontageWarmup Warmup;
+	for (const auto Montage : Montages)
+	{
+		if (!Montage) continue;
+
+		bool bAlreadyWarmed = false;
+		WarmedMontages.Add(MakeTuple(TObjectKey<USkeletalMesh>(SkeletalMesh), TObjectKey<UAnimMontage>(Montage)), &bAlreadyWarmed);
+		if (!bAlreadyWarmed)
+		{
+			Warmup.Montages.Add(Montage);
+		}
+	}
+	if (Warmup.Montages.Num() == 0) return;
+
+	if (!ProxyOwner)
+	{
+		// keeps the proxies away from the real fighters and their overlaps
+		FActorSpawnParameters SpawnParameters;
+		SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		SpawnParameters.ObjectFlags |= RF_Transient;
+		ProxyOwner = GetWorld()->SpawnActor<AActor>(AActor::StaticClass(),
+			FTransform(FVector(0.f, 0.f, -WarmupProxyDepth)), SpawnParameters);
+	}
+
+	// hidden, collision free copy that still evaluates its pose; a single node instance
+	// scrubs the montages without running the fighter's anim blueprint
+	const auto Proxy = NewObject<USkeletalMeshComponent>(ProxyOwner);
+	Proxy->SetSkeletalMeshAsset(SkeletalMesh);
+	Proxy->SetAnimationMode(EAnimationMode::AnimationSingleNode);
+	Proxy->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	Proxy->SetHiddenInGame(true);
+	Proxy->SetCastShadow(false);
+	Proxy->VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::AlwaysTickPoseAndRefreshBones;
+	Proxy->SetWorldLocation(FVector(0.f, 0.f, -WarmupProxyDepth));
+	Proxy->RegisterComponent();
+
+	Warmup.Proxy = Proxy;
+	Warmups.Add(MoveTemp(Warmup));
+}
+
+bool UEncounterPreparationSubsystem::TickMontageWarmup(FMontageWarmup& Warmup)
+{
+	if (!Warmup.Proxy) return true;
+
+	if (Warmup.NextMontage < Warmup.Montages.Num())
+	{
+		// one montage per frame, paused and scrubbed rather than played: playing would
+		// fire its notifies (swing sounds, sparks, ...) for real, a scrub with notifies
+		// off only evaluates the pose
+		const auto Montage = Warmup.Montages[Warmup.NextMontage];
+		Warmup.Proxy->SetAnimation(Montage);
+		if (const auto SingleNodeInstance = Warmup.Proxy->GetSingleNodeInstance())
+		{
+			SingleNodeInstance->SetPlaying(false);
+			SingleNodeInstance->SetPosition(Montage->GetPlayLength() * .5f, false);
+		}
+		++Warmup.NextMontage;
+		return false;
+	}
+
+	Warmup.Proxy->DestroyComponent();
+	Warmup.Proxy = nullptr;
+	return true;
+}
+
+void UEncounterPreparationSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	for (int32 Index = Warmups.Num() - 1; Index >= 0; --Index)
+	{
+		if (TickMontageWarmup(Warmups[Index]))
+		{
+			Warmups.RemoveAtSwap(Index);
+		}
+	}
+	if (Warmups.Num() == 0 && ProxyOwner)
+	{
+		ProxyOwner->Destroy();
+		ProxyOwner = nullptr;
+	}
+
+	// warmups are shared, so an encounter is ready once none are left in flight; they
+	// take a frame per montage, minions wait at most a few frames for the boss's
+	for (auto& Pair : Encounters)
+	{
+		auto& Preparation = Pair.Value;
+		if (Preparation.bPrepared) continue;
+
+		const auto bLoaded = !Preparation.LoadHandle.IsValid() || Preparation.LoadHandle->HasLoadCompleted();
+		if (bLoaded && Warmups.Num() == 0)
+		{
+			Preparation.bPrepared = true;
+			UE_LOG(LogTemp, Display, TEXT("Encounter %s prepared in %.1f ms"),
+				*GetNameSafe(Preparation.Enemy.Get()), (FPlatformTime::Seconds() - Preparation.StartTime) * 1000.);
+		}
+	}
+
+	TickHitchTracking();
+}
+
+bool UEncounterPreparationSubsystem::IsEncounterPrepared(const AEnemyBase* Enemy) const
+{
+	const auto Preparation = Encounters.Find(Enemy);
+	return Preparation && Preparation->bPrepared;
+}
+
+void UEncounterPreparationSubsystem::OnEncounterStarted(AEnemyBase* Enemy)
+{
+	if (CVarEncounterPrewarm.GetValueOnGameThread() != 0 && !IsEncounterPrepared(Enemy))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Encounter %s started before its preparation finished"), *GetNameSafe(Enemy));
+	}
+
+	// the window belongs to the boss fight, minions aggroing during it must not cut it short
+	if (!Cast<AEnemyBoss>(Enemy)) return;
+
+	TrackedEncounter = Enemy;
+	TrackedEncounterStartTime = FPlatformTime::Seconds();
+	TrackedFrames = 0;
+	TrackedHitches = 0;
+	TrackedWorstFrameMs = 0.f;
+}
+
+void UEncounterPreparationSubsystem::TickHitchTracking()
+{
+	if (!TrackedEncounter.IsValid()) return;
+
+	const auto FrameMs = FApp::GetDeltaTime() * 1000.;
+	const auto bHitch = FrameMs > CVarEncounterHitchThresholdMs.GetValueOnGameThread();
+	++TrackedFrames;
+	TrackedHitches += bHitch ? 1 : 0;
+	TrackedWorstFrameMs = FMath::Max(TrackedWorstFrameMs, static_cast<float>(FrameMs));
+	SET_DWORD_STAT(STAT_EncounterHitches, TrackedHitches);
+	CSV_CUSTOM_STAT(Combat, EncounterHitch, bHitch ? 1 : 0, ECsvCustomStatOp::Set);
+
+	if (FPlatformTime::Seconds() - TrackedEncounterStartTime >= CVarEncounterHitchWindow.GetValueOnGameThread())
+	{
+		UE_LOG(LogTemp, Display, TEXT("Encounter %s: %d hitches (> %.0f ms) in %d frames, worst frame %.1f ms, prewarm %s"),
+			*GetNameSafe(TrackedEncounter.Get()), TrackedHitches, CVarEncounterHitchThresholdMs.GetValueOnGameThread(),
+			TrackedFrames, TrackedWorstFrameMs, CVarEncounterPrewarm.GetValueOnGameThread() != 0 ? TEXT("on") : TEXT("off"));
+		TrackedEncounter.Reset();
+	}
+}
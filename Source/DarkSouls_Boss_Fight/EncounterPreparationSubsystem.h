@@ -0,0 +1,105 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "EncounterPreparationSubsystem.generated.h"
+
+class ACombatant;
+class AEnemyBase;
+class UAnimMontage;
+class USkeletalMesh;
+class USkeletalMeshComponent;
+struct FStreamableHandle;
+
+// Evaluates montages one per frame on a hidden copy of a skeletal mesh, notifies off
+USTRUCT()
+struct FMontageWarmup
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+		USkeletalMeshComponent* Proxy = nullptr;
+
+	UPROPERTY()
+		TArray<UAnimMontage*> Montages;
+
+	int32 NextMontage = 0;
+};
+
+struct FEncounterPreparation
+{
+	TWeakObjectPtr<AEnemyBase> Enemy;
+
+	TSharedPtr<FStreamableHandle> LoadHandle;
+
+	double StartTime = 0.;
+	bool bPrepared = false;
+};
+
+/**
+ * Gets a boss fight ready while the player is still approaching: streams in the
+ * enemy's encounter assets, requests PSO precaching for its and the player's
+ * components and evaluates their montages offscreen, so the first attack, stumble and
+ * roll don't hitch. Work is shared between enemies: every mesh/montage pair is warmed
+ * up and every rendered asset precached once per world, so a room full of minions of
+ * the same kind costs as much as one. Also counts hitches in the first seconds of
+ * every boss fight.
+ */
+UCLASS()
+class DARKSOULS_BOSS_FIGHT_API UEncounterPreparationSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	virtual void Deinitialize() override;
+
+	// a set lookup after the first call per enemy, fine to call every frame
+	void PrepareEncounter(AEnemyBase* Enemy, ACombatant* Opponent);
+
+	bool IsEncounterPrepared(const AEnemyBase* Enemy) const;
+
+	// the enemy aggroed: start counting hitches if it is a boss, minions joining in
+	// don't restart the window
+	void OnEncounterStarted(AEnemyBase* Enemy);
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	// PSO precache for every primitive whose asset and materials weren't precached yet
+	void PrecacheCombatant(ACombatant* Combatant);
+
+	// warm up the combatant's montages that haven't been evaluated on its mesh yet
+	void AddMontageWarmup(ACombatant* Combatant);
+
+	// true once every montage has been evaluated
+	bool TickMontageWarmup(FMontageWarmup& Warmup);
+
+	void TickHitchTracking();
+
+	TMap<TObjectKey<AEnemyBase>, FEncounterPreparation> Encounters;
+
+	// owns all warmup proxies, away from the real fighters
+	UPROPERTY(Transient)
+		AActor* ProxyOwner = nullptr;
+
+	UPROPERTY(Transient)
+		TArray<FMontageWarmup> Warmups;
+
+	// mesh/montage pairs already warmed up or in flight
+	TSet<TPair<TObjectKey<USkeletalMesh>, TObjectKey<UAnimMontage>>> WarmedMontages;
+
+	// hash of a primitive's class, asset and materials
+	TSet<uint32> PrecachedPrimitives;
+
+	TWeakObjectPtr<AEnemyBase> TrackedEncounter;
+	double TrackedEncounterStartTime = 0.;
+	int32 TrackedFrames = 0;
+	int32 TrackedHitches = 0;
+	float TrackedWorstFrameMs = 0.f;
+};
@@ -2,6 +2,8 @@
 
 
 #include "EnemyBase.h"
+#include "CombatEventBus.h"
+#include "EncounterPreparationSubsystem.h"
 #include "AIController.h"
 #include "Kismet/GameplayStatics.h"
 #include "Engine/World.h"
@@ -25,76 +27,153 @@ void AEnemyBase::BeginPlay()
 	Target = UGameplayStatics::GetPlayerPawn(GetWorld(), 0);
 }
 
-void AEnemyBase::Tick(float DeltaTime)
+void AEnemyBase::GatherSnapshot(FCombatantSnapshot& Snapshot) const
 {
-	Super::Tick(DeltaTime);
-	TickStateMachine();
+	Super::GatherSnapshot(Snapshot);
+	Snapshot.Compute = &AEnemyBase::ComputeDecision;
+	Snapshot.ActiveState = ActiveState;
+	Snapshot.AggroDistance = AggroDistance;
+	Snapshot.EncounterPrepareDistance = EncounterPrepareDistance;
 }
 
-void AEnemyBase::TickStateMachine()
+void AEnemyBase::ComputeDecision(const FCombatantSnapshot& Snapshot, FCombatantDecision& Decision)
 {
-	switch (ActiveState)
+	ACombatant::ComputeDecision(Snapshot, Decision);
+
+	switch (Snapshot.ActiveState)
 	{
 	case State::IDLE:
-		StateIdle();
+		DecideIdle(Snapshot, Decision);
 		break;
 	case State::CHASE_CLOSE:
-		StateChaseClose();
+		DecideChaseClose(Snapshot, Decision);
 		break;
 	case State::CHASE_FAR:
-		StateChaseFar();
+		DecideChaseFar(Snapshot, Decision);
 		break;
 	case State::ATTACK:
-		StateAttack();
+		DecideAttack(Snapshot, Decision);
 		break;
 	case State::STUMBLE:
-		StateStumble();
+		DecideStumble(Snapshot, Decision);
 		break;
 	//case State::TAUNT:
 	//	break;
-	case State::DEAD:
-		StateDead();
+	default:
+		break;
+	}
+}
+
+bool AEnemyBase::IsSnapshotCurrent(const FCombatantSnapshot& Snapshot) const
+{
+	return Super::IsSnapshotCurrent(Snapshot) && Snapshot.ActiveState == ActiveState;
+}
+
+void AEnemyBase::CommitDecision(const FCombatantDecision& Decision)
+{
+	Super::CommitDecision(Decision);
+
+	const auto EncounterPreparation = GetWorld()->GetSubsystem<UEncounterPreparationSubsystem>();
+	if (Decision.bPrepareEncounter && EncounterPreparation)
+	{
+		EncounterPreparation->PrepareEncounter(this, Cast<ACombatant>(Target));
+	}
+	if (Decision.bLockTarget)
+	{
+		if (!bTargetLocked && EncounterPreparation)
+		{
+			EncounterPreparation->OnEncounterStarted(this);
+		}
+		bTargetLocked = true;
+	}
+	if (Decision.bChangeState)
+	{
+		SetState(Decision.NewState);
+	}
+	if (Decision.bApplyWeaponDamage)
+	{
+		ApplyWeaponDamage();
+	}
+
+	switch (Decision.Action)
+	{
+	case ECombatantAction::Attack:
+		Attack(false);
+		break;
+	case ECombatantAction::MoveToTarget:
+		MoveToTarget();
+		break;
+	case ECombatantAction::MoveForward:
+		MoveForward();
+		break;
+	case ECombatantAction::StepBack:
+		AddMovementInput(-GetActorForwardVector(), 10.f * GetWorld()->GetDeltaSeconds());
+		break;
+	default:
 		break;
 	}
 }
 
 void AEnemyBase::SetState(State NewState)
 {
-	if (ActiveState != State::DEAD)
+	if (ActiveState != State::DEAD && ActiveState != NewState)
 	{
+		if (EventBus)
+		{
+			FCombatEvent Event;
+			Event.Type = ECombatEventType::StateChanged;
+			Event.Source = this;
+			Event.Location = GetActorLocation();
+			Event.OldState = static_cast<uint8>(ActiveState);
+			Event.NewState = static_cast<uint8>(NewState);
+			Event.TimeSeconds = GetWorld()->GetTimeSeconds();
+			EventBus->Push(Event);
+		}
 		ActiveState = NewState;
 	}
 }
 
-void AEnemyBase::StateIdle()
+void AEnemyBase::DecideIdle(const FCombatantSnapshot& Snapshot, FCombatantDecision& Decision)
 {
-	if (Target && FVector::Dist(Target->GetActorLocation(), GetActorLocation()) <= 1200.f)
+	if (!Snapshot.bHasTarget) return;
+
+	const auto Distance = FVector::Dist(Snapshot.TargetLocation, Snapshot.Location);
+	Decision.bPrepareEncounter = Distance <= FMath::Max(Snapshot.EncounterPrepareDistance, Snapshot.AggroDistance);
+	if (Distance <= Snapshot.AggroDistance)
 	{
-		bTargetLocked = true;
-		SetState(State::CHASE_CLOSE);
+		Decision.bLockTarget = true;
+		Decision.bChangeState = true;
+		Decision.NewState = State::CHASE_CLOSE;
 	}
 }
 
-void AEnemyBase::StateChaseClose()
+void AEnemyBase::DecideChaseClose(const FCombatantSnapshot& Snapshot, FCombatantDecision& Decision)
 {
-	const auto Distance = FVector::Distance(Target->GetActorLocation(), GetActorLocation());
+	if (!Snapshot.bHasTarget) return;
+
+	const auto Distance = FVector::Distance(Snapshot.TargetLocation, Snapshot.Location);
 	if (Distance <= 300.)
 	{
-		const auto TargetDirection = Target->GetActorLocation() - GetActorLocation();
-		const auto DotProduct = FVector::DotProduct(GetActorForwardVector(),
+		const auto TargetDirection = Snapshot.TargetLocation - Snapshot.Location;
+		const auto DotProduct = FVector::DotProduct(Snapshot.Forward,
 			TargetDirection.GetSafeNormal());
-		if (DotProduct > .95f && !bAttacking && !bStumbling)
+		if (DotProduct > .95f && !Snapshot.bAttacking && !Snapshot.bStumbling)
 		{
-			Attack(false);
+			Decision.Action = ECombatantAction::Attack;
 		}
 	}
 	else
 	{
-		const auto AIController = Cast<AAIController>(Controller);
-		if (AIController && !AIController->IsFollowingAPath())
-		{
-			AIController->MoveToActor(Target);
-		}
+		Decision.Action = ECombatantAction::MoveToTarget;
+	}
+}
+
+void AEnemyBase::MoveToTarget()
+{
+	const auto AIController = Cast<AAIController>(Controller);
+	if (AIController && !AIController->IsFollowingAPath())
+	{
+		AIController->MoveToActor(Target);
 	}
 }
 
@@ -141,63 +220,69 @@ void AEnemyBase::AttackLunge()
 	Super::AttackLunge();
 }
 
-void AEnemyBase::StateChaseFar()
+void AEnemyBase::DecideChaseFar(const FCombatantSnapshot& Snapshot, FCombatantDecision& Decision)
 {
-	if (FVector::Dist(Target->GetActorLocation(), GetActorLocation()) < 850.)
+	if (Snapshot.bHasTarget && FVector::Dist(Snapshot.TargetLocation, Snapshot.Location) < 850.)
 	{
-		SetState(State::CHASE_CLOSE);
+		Decision.bChangeState = true;
+		Decision.NewState = State::CHASE_CLOSE;
 	}
 }
 
-void AEnemyBase::StateAttack()
+void AEnemyBase::DecideAttack(const FCombatantSnapshot& Snapshot, FCombatantDecision& Decision)
 {
-	if (bAttackDamaging)
-	{
-		TSet<AActor*> OverlappingActors;
-		Weapon->GetOverlappingActors(OverlappingActors);
+	Decision.bApplyWeaponDamage = Snapshot.bAttackDamaging;
 
-		for (const auto OtherActor : OverlappingActors)
-		{
-			if (OtherActor == this) continue;
-
-			if (!AttackHitActors.Contains(OtherActor))
-			{
-				const auto AppliedDamage = UGameplayStatics::ApplyDamage(OtherActor, 1.f, GetController(), this, UDamageType::StaticClass());
-				if (AppliedDamage > 0.f)
-				{
-					AttackHitActors.Add(OtherActor);
-				}
-			}
-		}
-	}
-
-	if (bMovingForward)
+	if (Snapshot.bMovingForward)
 	{
-		MoveForward();
+		Decision.Action = ECombatantAction::MoveForward;
 	}
 }
 
-void AEnemyBase::StateStumble()
+void AEnemyBase::DecideStumble(const FCombatantSnapshot& Snapshot, FCombatantDecision& Decision)
 {
-	if (bStumbling)
+	if (Snapshot.bStumbling)
 	{
-		if (bMovingBackwards)
+		if (Snapshot.bMovingBackwards)
 		{
-			AddMovementInput(-GetActorForwardVector(), 10.f * GetWorld()->GetDeltaSeconds());
+			Decision.Action = ECombatantAction::StepBack;
 		}
 	}
 	else
 	{
-		SetState(State::CHASE_CLOSE);
+		Decision.bChangeState = true;
+		Decision.NewState = State::CHASE_CLOSE;
 	}
 }
 
-void AEnemyBase::StateTaunt()
+void AEnemyBase::ApplyWeaponDamage()
 {
+	TSet<AActor*> OverlappingActors;
+	Weapon->GetOverlappingActors(OverlappingActors);
+
+	for (const auto OtherActor : OverlappingActors)
+	{
+		if (OtherActor == this) continue;
+
+		if (!AttackHitActors.Contains(OtherActor))
+		{
+			const auto AppliedDamage = UGameplayStatics::ApplyDamage(OtherActor, 1.f, GetController(), this, UDamageType::StaticClass());
+			if (AppliedDamage > 0.f)
+			{
+				AttackHitActors.Add(OtherActor);
+				PushCombatEvent(ECombatEventType::HitLanded, OtherActor, AppliedDamage);
+			}
+		}
+	}
 }
 
-void AEnemyBase::StateDead()
+void AEnemyBase::GetWarmupMontages(TArray<UAnimMontage*>& OutMontages) const
 {
+	Super::GetWarmupMontages(OutMontages);
+	if (OverheadSmash)
+	{
+		OutMontages.Add(OverheadSmash);
+	}
 }
 
 void AEnemyBase::FocusTarget()
@@ -229,6 +314,7 @@ float AEnemyBase::TakeDamage(float DamageAmount, FDamageEvent const& DamageEvent
 	} while (AnimationIndex == LastStumbleIndex);
 	PlayAnimMontage(TakeHit_StumbleBackwards[AnimationIndex]);
 	LastStumbleIndex = AnimationIndex;
+	PushCombatEvent(ECombatEventType::StumbleStarted, DamageCauser, DamageAmount);
 
 	auto Direction = DamageCauser->GetActorLocation() - GetActorLocation();
 	Direction.Z = 0;
@@ -7,18 +7,6 @@
 #include "EnemyBase.generated.h"
 
 
-UENUM(BlueprintType)
-enum class State : uint8
-{
-	IDLE,					// Outside of combat
-	CHASE_CLOSE,			// Combat, staying close to target
-	CHASE_FAR,				// Combat, doesn't care about range
-	ATTACK,					// In the process of attacking
-	STUMBLE,				// Stumbling from being damaged/interrupted
-	TAUNT,					// Emoting during a fight
-	DEAD					// Dead
-};
-
 UCLASS()
 class DARKSOULS_BOSS_FIGHT_API AEnemyBase : public ACombatant
 {
@@ -40,31 +28,44 @@ public:
 	UPROPERTY(EditAnywhere, Category = "Animations")
 		UAnimMontage* OverheadSmash;
 
+	// distance at which the enemy notices its target
+	UPROPERTY(EditAnywhere, Category = "Combat")
+		float AggroDistance = 1200.f;
+
+	// distance at which the encounter starts preparing, has to leave time before aggro
+	UPROPERTY(EditAnywhere, Category = "Encounter")
+		float EncounterPrepareDistance = 3500.f;
+
+	// assets only this fight needs, streamed in while the player approaches
+	UPROPERTY(EditAnywhere, Category = "Encounter")
+		TArray<TSoftObjectPtr<UObject>> EncounterAssets;
+
+	virtual void GetWarmupMontages(TArray<UAnimMontage*>& OutMontages) const override;
+
 int32 LastStumbleIndex = 0;
 
 protected:
 
 	virtual void BeginPlay() override;
 
-	virtual void TickStateMachine();
-
 	void SetState(State NewState);
 
-	virtual void StateIdle();
+	static void DecideIdle(const FCombatantSnapshot& Snapshot, FCombatantDecision& Decision);
 
 	// state: actively trying to keep close and attack the target
-	virtual void StateChaseClose();
+	static void DecideChaseClose(const FCombatantSnapshot& Snapshot, FCombatantDecision& Decision);
 
 	// state: engaged but not currently trying to attack (idle behavior)
-	virtual void StateChaseFar();
+	static void DecideChaseFar(const FCombatantSnapshot& Snapshot, FCombatantDecision& Decision);
 
-	virtual void StateAttack();
+	static void DecideAttack(const FCombatantSnapshot& Snapshot, FCombatantDecision& Decision);
 
-	virtual void StateStumble();
+	static void DecideStumble(const FCombatantSnapshot& Snapshot, FCombatantDecision& Decision);
 
-	virtual void StateTaunt();
+	// game thread: damage everything the weapon overlaps that was not hit yet
+	void ApplyWeaponDamage();
 
-	virtual void StateDead();
+	void MoveToTarget();
 
 	virtual void MoveForward();
 
@@ -80,7 +81,13 @@ protected:
 
 public:
 
-	virtual void Tick(float DeltaTime) override;
+	virtual void GatherSnapshot(FCombatantSnapshot& Snapshot) const override;
+
+	static void ComputeDecision(const FCombatantSnapshot& Snapshot, FCombatantDecision& Decision);
+
+	virtual bool IsSnapshotCurrent(const FCombatantSnapshot& Snapshot) const override;
+
+	virtual void CommitDecision(const FCombatantDecision& Decision) override;
 
 	virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
 
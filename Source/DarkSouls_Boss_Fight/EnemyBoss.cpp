@@ -13,37 +13,76 @@ AEnemyBoss::AEnemyBoss()
 
 }
 
-void AEnemyBoss::StateChaseClose()
+void AEnemyBoss::GatherSnapshot(FCombatantSnapshot& Snapshot) const
 {
-	const auto Distance = FVector::Dist(GetActorLocation(), Target->GetActorLocation());
-	if (const auto AIController = Cast<AAIController>(Controller))
+	Super::GatherSnapshot(Snapshot);
+	Snapshot.Compute = &AEnemyBoss::ComputeDecision;
+	Snapshot.LongAttackReadyTime = LongAttack_Timestamp + LongAttack_Cooldown;
+}
+
+void AEnemyBoss::ComputeDecision(const FCombatantSnapshot& Snapshot, FCombatantDecision& Decision)
+{
+	if (Snapshot.ActiveState == State::CHASE_CLOSE)
+	{
+		ACombatant::ComputeDecision(Snapshot, Decision);
+		DecideChaseClose(Snapshot, Decision);
+	}
+	else
 	{
-		const auto TargetDirection = Target->GetActorLocation() - GetActorLocation();
-		const auto DotProduct = FVector::DotProduct(GetActorForwardVector(), TargetDirection.GetSafeNormal());
-		if (Distance <= 900. && DotProduct >= .95)
+		AEnemyBase::ComputeDecision(Snapshot, Decision);
+	}
+}
+
+void AEnemyBoss::DecideChaseClose(const FCombatantSnapshot& Snapshot, FCombatantDecision& Decision)
+{
+	if (!Snapshot.bHasTarget) return;
+
+	const auto Distance = FVector::Dist(Snapshot.Location, Snapshot.TargetLocation);
+	const auto TargetDirection = Snapshot.TargetLocation - Snapshot.Location;
+	const auto DotProduct = FVector::DotProduct(Snapshot.Forward, TargetDirection.GetSafeNormal());
+	if (Distance <= 900. && DotProduct >= .95)
+	{
+		if (Distance <= 300.)
 		{
-			if (Distance <= 300.)
-			{
-				Attack(false);
-				return;
-			}
+			Decision.Action = ECombatantAction::Attack;
+			return;
 		}
-		else if (UGameplayStatics::GetTimeSeconds(GetWorld()) >=
-			LongAttack_Timestamp + LongAttack_Cooldown &&
-			AIController->LineOfSightTo(Target))
+	}
+	else if (Snapshot.TimeSeconds >= Snapshot.LongAttackReadyTime)
+	{
+		// line of sight needs a trace, so the commit phase falls back to chasing if it fails
+		Decision.Action = ECombatantAction::LongAttack;
+		return;
+	}
+
+	Decision.Action = ECombatantAction::MoveToTarget;
+}
+
+void AEnemyBoss::CommitDecision(const FCombatantDecision& Decision)
+{
+	Super::CommitDecision(Decision);
+
+	if (Decision.Action == ECombatantAction::LongAttack)
+	{
+		const auto AIController = Cast<AAIController>(Controller);
+		if (AIController && AIController->LineOfSightTo(Target))
 		{
 			LongAttack_Timestamp = UGameplayStatics::GetTimeSeconds(GetWorld());
 			LongAttack(true);
-			return;
 		}
-
-		if (!AIController->IsFollowingAPath())
+		else
 		{
-			AIController->MoveToActor(Target);
+			MoveToTarget();
 		}
 	}
 }
 
+void AEnemyBoss::GetWarmupMontages(TArray<UAnimMontage*>& OutMontages) const
+{
+	Super::GetWarmupMontages(OutMontages);
+	OutMontages.Append(LongAttackAnimations);
+}
+
 void AEnemyBoss::LongAttack(bool Rotate)
 {
 	Super::Attack();
@@ -24,9 +24,17 @@ public:
 	float TakeDamage(float DamageAmount, FDamageEvent const& DamageEvent,
 		AController* EventInstigator, AActor* DamageCauser);
 
+	virtual void GatherSnapshot(FCombatantSnapshot& Snapshot) const override;
+
+	static void ComputeDecision(const FCombatantSnapshot& Snapshot, FCombatantDecision& Decision);
+
+	virtual void CommitDecision(const FCombatantDecision& Decision) override;
+
+	virtual void GetWarmupMontages(TArray<UAnimMontage*>& OutMontages) const override;
+
 protected:
 
-	void StateChaseClose();
+	static void DecideChaseClose(const FCombatantSnapshot& Snapshot, FCombatantDecision& Decision);
 	void LongAttack(bool Rotate = true);
 	void MoveForward();
 
@@ -0,0 +1,245 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "HitFeedbackSubsystem.h"
+#include "Combatant.h"
+#include "CombatEventBus.h"
+#include "DarkSouls_Boss_Fight.h"
+#include "Camera/CameraShakeBase.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Components/AudioComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "NiagaraComponent.h"
+#include "NiagaraSystem.h"
+#include "Sound/SoundBase.h"
+
+DECLARE_CYCLE_STAT(TEXT("Hit Feedback"), STAT_HitFeedback, STATGROUP_Combat);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Hit Feedback Events"), STAT_HitFeedbackEvents, STATGROUP_Combat);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Hit Feedback Capped"), STAT_HitFeedbackCapped, STATGROUP_Combat);
+
+static TAutoConsoleVariable<int32> CVarHitFeedbackPoolSize(
+	TEXT("Combat.HitFeedback.PoolSize"),
+	8,
+	TEXT("Components pre-allocated per hit sparks system and per hit sound."));
+
+static TAutoConsoleVariable<int32> CVarHitFeedbackMaxPerFrame(
+	TEXT("Combat.HitFeedback.MaxPerFrame"),
+	4,
+	TEXT("Maximum coalesced hit feedback events (sparks + sound) played per frame, the local player's own hits don't count."));
+
+static TAutoConsoleVariable<float> CVarHitFeedbackScalePerHit(
+	TEXT("Combat.HitFeedback.ScalePerHit"),
+	.25f,
+	TEXT("Extra feedback scale for every hit beyond the first in the same frame."));
+
+static TAutoConsoleVariable<float> CVarHitFeedbackMaxScale(
+	TEXT("Combat.HitFeedback.MaxScale"),
+	2.f,
+	TEXT("Upper bound of the coalesced feedback scale."));
+
+bool UHitFeedbackSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UHitFeedbackSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	if (const auto EventBus = Collection.InitializeDependency<UCombatEventBus>())
+	{
+		EventsDrainedHandle = EventBus->OnEventsDrained.AddUObject(this, &UHitFeedbackSubsystem::OnCombatEventsDrained);
+	}
+}
+
+void UHitFeedbackSubsystem::Deinitialize()
+{
+	if (const auto EventBus = GetWorld()->GetSubsystem<UCombatEventBus>())
+	{
+		EventBus->OnEventsDrained.Remove(EventsDrainedHandle);
+	}
+
+	for (auto& Pool : SparksPools)
+	{
+		for (const auto Component : Pool.Value.Components)
+		{
+			if (Component) Component->DestroyComponent();
+		}
+	}
+	for (auto& Pool : SoundPools)
+	{
+		for (const auto Component : Pool.Value.Components)
+		{
+			if (Component) Component->DestroyComponent();
+		}
+	}
+	SparksPools.Empty();
+	SoundPools.Empty();
+
+	Super::Deinitialize();
+}
+
+void UHitFeedbackSubsystem::Prewarm(const FHitFeedback& Feedback)
+{
+	const auto World = GetWorld();
+	const auto PoolSize = FMath::Max(1, CVarHitFeedbackPoolSize.GetValueOnGameThread());
+
+	if (Feedback.Sparks && !SparksPools.Contains(Feedback.Sparks))
+	{
+		auto& Pool = SparksPools.Add(Feedback.Sparks);
+		Pool.Components.Reserve(PoolSize);
+		for (int32 Index = 0; Index < PoolSize; ++Index)
+		{
+			const auto Component = NewObject<UNiagaraComponent>(World);
+			Component->SetAutoActivate(false);
+			Component->SetAutoDestroy(false);
+			Component->SetAsset(Feedback.Sparks);
+			Component->RegisterComponentWithWorld(World);
+			Pool.Components.Add(Component);
+		}
+	}
+
+	if (Feedback.Sound && !SoundPools.Contains(Feedback.Sound))
+	{
+		auto& Pool = SoundPools.Add(Feedback.Sound);
+		Pool.Components.Reserve(PoolSize);
+		for (int32 Index = 0; Index < PoolSize; ++Index)
+		{
+			const auto Component = NewObject<UAudioComponent>(World);
+			Component->bAutoActivate = false;
+			Component->bAutoDestroy = false;
+			Component->bAllowSpatialization = true;
+			Component->SetSound(Feedback.Sound);
+			Component->RegisterComponentWithWorld(World);
+			Pool.Components.Add(Component);
+		}
+	}
+}
+
+UNiagaraComponent* UHitFeedbackSubsystem::AcquireSparks(UNiagaraSystem* System)
+{
+	auto Pool = SparksPools.Find(System);
+	if (!Pool || Pool->Components.Num() == 0) return nullptr;
+
+	// prefer an idle component, otherwise recycle the oldest one
+	const auto Num = Pool->Components.Num();
+	auto Index = Pool->NextIndex % Num;
+	for (int32 Offset = 0; Offset < Num; ++Offset)
+	{
+		const auto Candidate = (Pool->NextIndex + Offset) % Num;
+		if (!Pool->Components[Candidate]->IsActive())
+		{
+			Index = Candidate;
+			break;
+		}
+	}
+	Pool->NextIndex = (Index + 1) % Num;
+	return Pool->Components[Index];
+}
+
+UAudioComponent* UHitFeedbackSubsystem::AcquireSound(USoundBase* Sound)
+{
+	auto Pool = SoundPools.Find(Sound);
+	if (!Pool || Pool->Components.Num() == 0) return nullptr;
+
+	const auto Num = Pool->Components.Num();
+	auto Index = Pool->NextIndex % Num;
+	for (int32 Offset = 0; Offset < Num; ++Offset)
+	{
+		const auto Candidate = (Pool->NextIndex + Offset) % Num;
+		if (!Pool->Components[Candidate]->IsPlaying())
+		{
+			Index = Candidate;
+			break;
+		}
+	}
+	Pool->NextIndex = (Index + 1) % Num;
+	return Pool->Components[Index];
+}
+
+void UHitFeedbackSubsystem::OnCombatEventsDrained(TArrayView<const FCombatEvent> Events)
+{
+	SCOPE_CYCLE_COUNTER(STAT_HitFeedback);
+
+	// one entry per source: all of its hits this frame become a single feedback event
+	CoalescedHits.Reset();
+	for (const auto& Event : Events)
+	{
+		if (Event.Type != ECombatEventType::HitLanded || !Event.Source.IsValid()) continue;
+
+		auto Coalesced = CoalescedHits.FindByPredicate([&Event](const FCoalescedHit& Hit)
+		{
+			return Hit.Source == Event.Source;
+		});
+		if (!Coalesced)
+		{
+			Coalesced = &CoalescedHits.AddDefaulted_GetRef();
+			Coalesced->Source = Event.Source;
+		}
+		Coalesced->LocationSum += Event.Location;
+		++Coalesced->HitCount;
+	}
+
+	// the local player's own hits are exempt from the cap: enemy hits are pushed earlier in
+	// the frame and would otherwise crowd them out when several enemies connect at once
+	const auto MaxPerFrame = CVarHitFeedbackMaxPerFrame.GetValueOnGameThread();
+	int32 Played = 0;
+	int32 PlayedUnderCap = 0;
+	int32 Capped = 0;
+	for (const auto& Hit : CoalescedHits)
+	{
+		const auto Combatant = Cast<ACombatant>(Hit.Source.Get());
+		if (!Combatant) continue;
+
+		const auto bLocalPlayer = Combatant->IsLocallyControlled() && Combatant->IsPlayerControlled();
+		if (!bLocalPlayer && PlayedUnderCap >= MaxPerFrame)
+		{
+			++Capped;
+			continue;
+		}
+
+		PlayFeedback(Combatant->GetHitFeedback(), Combatant, Hit.LocationSum / Hit.HitCount, Hit.HitCount);
+		++Played;
+		PlayedUnderCap += bLocalPlayer ? 0 : 1;
+	}
+
+	SET_DWORD_STAT(STAT_HitFeedbackEvents, Played);
+	SET_DWORD_STAT(STAT_HitFeedbackCapped, Capped);
+}
+
+void UHitFeedbackSubsystem::PlayFeedback(const FHitFeedback& Feedback, APawn* Source, const FVector& Location, int32 HitCount)
+{
+	const auto Scale = FMath::Min(1.f + (HitCount - 1) * CVarHitFeedbackScalePerHit.GetValueOnGameThread(),
+		CVarHitFeedbackMaxScale.GetValueOnGameThread());
+
+	if (Feedback.Sparks)
+	{
+		if (const auto Sparks = AcquireSparks(Feedback.Sparks))
+		{
+			Sparks->SetWorldLocation(Location);
+			Sparks->SetVariableFloat(TEXT("User.HitScale"), Scale);
+			Sparks->SetVariableInt(TEXT("User.HitCount"), HitCount);
+			Sparks->Activate(true);
+		}
+	}
+
+	if (Feedback.Sound)
+	{
+		if (const auto Sound = AcquireSound(Feedback.Sound))
+		{
+			Sound->SetWorldLocation(Location);
+			Sound->SetVolumeMultiplier(Scale);
+			Sound->Play();
+		}
+	}
+
+	// the camera shake modifier recycles expired shake instances of the same class
+	const auto PlayerController = Cast<APlayerController>(Source->GetController());
+	if (Feedback.CameraShake && PlayerController && PlayerController->IsLocalController() &&
+		PlayerController->PlayerCameraManager)
+	{
+		PlayerController->PlayerCameraManager->StartCameraShake(Feedback.CameraShake, Scale);
+	}
+}
@@ -0,0 +1,101 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "CombatEvents.h"
+#include "HitFeedbackSubsystem.generated.h"
+
+class APawn;
+class UAudioComponent;
+class UCameraShakeBase;
+class UNiagaraComponent;
+class UNiagaraSystem;
+class USoundBase;
+
+// What a combatant's landed hits look, sound and feel like
+USTRUCT(BlueprintType)
+struct FHitFeedback
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Feedback")
+		UNiagaraSystem* Sparks = nullptr;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Feedback")
+		USoundBase* Sound = nullptr;
+
+	// only played for hits landed by the local player
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Feedback")
+		TSubclassOf<UCameraShakeBase> CameraShake;
+};
+
+USTRUCT()
+struct FNiagaraHitPool
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+		TArray<UNiagaraComponent*> Components;
+
+	int32 NextIndex = 0;
+};
+
+USTRUCT()
+struct FAudioHitPool
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+		TArray<UAudioComponent*> Components;
+
+	int32 NextIndex = 0;
+};
+
+/**
+ * Turns this frame's landed hits into feedback. Hits from the same source are coalesced
+ * into one event scaled by hit count, effects come from pools filled when combatants
+ * register, and per-frame caps keep multi-hit attacks from spiking the frame.
+ */
+UCLASS()
+class DARKSOULS_BOSS_FIGHT_API UHitFeedbackSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	// fills the pools for these assets so that hits never allocate
+	void Prewarm(const FHitFeedback& Feedback);
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	void OnCombatEventsDrained(TArrayView<const FCombatEvent> Events);
+
+	void PlayFeedback(const FHitFeedback& Feedback, APawn* Source, const FVector& Location, int32 HitCount);
+
+	UNiagaraComponent* AcquireSparks(UNiagaraSystem* System);
+	UAudioComponent* AcquireSound(USoundBase* Sound);
+
+	UPROPERTY(Transient)
+		TMap<UNiagaraSystem*, FNiagaraHitPool> SparksPools;
+
+	UPROPERTY(Transient)
+		TMap<USoundBase*, FAudioHitPool> SoundPools;
+
+	struct FCoalescedHit
+	{
+		TWeakObjectPtr<AActor> Source;
+		FVector LocationSum = FVector::ZeroVector;
+		int32 HitCount = 0;
+	};
+
+	// reused every frame
+	TArray<FCoalescedHit> CoalescedHits;
+
+	FDelegateHandle EventsDrainedHandle;
+};
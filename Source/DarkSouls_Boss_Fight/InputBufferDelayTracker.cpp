@@ -0,0 +1,149 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InputBufferDelayTracker.h"
+#include "DarkSouls_Boss_Fight.h"
+#include "PlayerCharacter.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Kismet/GameplayStatics.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+// accumulators keep the last value between presses, counters would be cleared every frame
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Attack Input Buffer Delay (ms)"), STAT_AttackInputBufferDelay, STATGROUP_Combat);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Roll Input Buffer Delay (ms)"), STAT_RollInputBufferDelay, STATGROUP_Combat);
+
+const float FInputBufferDelayTracker::BucketUpperBoundsMs[NumBuckets - 1] = { 8.f, 17.f, 33.f, 50.f, 100.f, 200.f, 300.f, 500.f };
+
+const TCHAR* FInputBufferDelayTracker::GetActionName(EBufferedAction Action)
+{
+	switch (Action)
+	{
+	case EBufferedAction::Attack:
+		return TEXT("Attack");
+	case EBufferedAction::Roll:
+		return TEXT("Roll");
+	default:
+		return TEXT("Unknown");
+	}
+}
+
+void FInputBufferDelayTracker::Record(EBufferedAction Action, double DelayMs)
+{
+	auto& Histogram = Histograms[static_cast<int32>(Action)];
+
+	int32 Bucket = 0;
+	while (Bucket < NumBuckets - 1 && DelayMs > BucketUpperBoundsMs[Bucket])
+	{
+		++Bucket;
+	}
+	++Histogram.Buckets[Bucket];
+	++Histogram.Count;
+	Histogram.SumMs += DelayMs;
+	Histogram.MaxMs = FMath::Max(Histogram.MaxMs, DelayMs);
+
+	if (Action == EBufferedAction::Attack)
+	{
+		SET_FLOAT_STAT(STAT_AttackInputBufferDelay, DelayMs);
+	}
+	else
+	{
+		SET_FLOAT_STAT(STAT_RollInputBufferDelay, DelayMs);
+	}
+}
+
+void FInputBufferDelayTracker::Reset()
+{
+	for (auto& Histogram : Histograms)
+	{
+		Histogram = FHistogram();
+	}
+}
+
+void FInputBufferDelayTracker::DumpToLog() const
+{
+	for (int32 ActionIndex = 0; ActionIndex < static_cast<int32>(EBufferedAction::Count); ++ActionIndex)
+	{
+		const auto& Histogram = Histograms[ActionIndex];
+		UE_LOG(LogTemp, Display, TEXT("%s input buffer delay: %d samples, avg %.2f ms, max %.2f ms"),
+			GetActionName(static_cast<EBufferedAction>(ActionIndex)), Histogram.Count,
+			Histogram.Count > 0 ? Histogram.SumMs / Histogram.Count : 0., Histogram.MaxMs);
+
+		for (int32 Bucket = 0; Bucket < NumBuckets; ++Bucket)
+		{
+			const auto LowerMs = Bucket == 0 ? 0.f : BucketUpperBoundsMs[Bucket - 1];
+			if (Bucket < NumBuckets - 1)
+			{
+				UE_LOG(LogTemp, Display, TEXT("  %5.0f - %5.0f ms: %d"), LowerMs, BucketUpperBoundsMs[Bucket], Histogram.Buckets[Bucket]);
+			}
+			else
+			{
+				UE_LOG(LogTemp, Display, TEXT("  %5.0f+        ms: %d"), LowerMs, Histogram.Buckets[Bucket]);
+			}
+		}
+	}
+}
+
+bool FInputBufferDelayTracker::ExportCsv(const FString& FilePath) const
+{
+	FString Csv = TEXT("Action,BufferDelayLowerMs,BufferDelayUpperMs,Count\n");
+	for (int32 ActionIndex = 0; ActionIndex < static_cast<int32>(EBufferedAction::Count); ++ActionIndex)
+	{
+		const auto& Histogram = Histograms[ActionIndex];
+		for (int32 Bucket = 0; Bucket < NumBuckets; ++Bucket)
+		{
+			const auto LowerMs = Bucket == 0 ? 0.f : BucketUpperBoundsMs[Bucket - 1];
+			const auto UpperText = Bucket < NumBuckets - 1 ? FString::SanitizeFloat(BucketUpperBoundsMs[Bucket]) : FString();
+			Csv += FString::Printf(TEXT("%s,%s,%s,%d\n"), GetActionName(static_cast<EBufferedAction>(ActionIndex)),
+				*FString::SanitizeFloat(LowerMs), *UpperText, Histogram.Buckets[Bucket]);
+		}
+	}
+	return FFileHelper::SaveStringToFile(Csv, *FilePath);
+}
+
+static APlayerCharacter* GetBufferDelayPlayer(UWorld* World)
+{
+	return World ? Cast<APlayerCharacter>(UGameplayStatics::GetPlayerPawn(World, 0)) : nullptr;
+}
+
+static FAutoConsoleCommandWithWorld CombatInputBufferDelayCommand(
+	TEXT("Combat.InputBufferDelay"),
+	TEXT("Logs how long the player's attack and roll presses waited in the input buffer."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (const auto Player = GetBufferDelayPlayer(World))
+		{
+			Player->GetInputBufferDelay().DumpToLog();
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs CombatInputBufferDelayExportCommand(
+	TEXT("Combat.InputBufferDelay.Export"),
+	TEXT("Writes the player's input buffer delay histograms as CSV. Args: [File=<ProfilingDir>/InputBufferDelay.csv]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		const auto Player = GetBufferDelayPlayer(World);
+		if (!Player) return;
+
+		const auto FilePath = Args.Num() > 0 ? Args[0] : FPaths::ProfilingDir() / TEXT("InputBufferDelay.csv");
+		if (Player->GetInputBufferDelay().ExportCsv(FilePath))
+		{
+			UE_LOG(LogTemp, Display, TEXT("Input buffer delay written to %s"), *FilePath);
+		}
+		else
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Could not write input buffer delay to %s"), *FilePath);
+		}
+	}));
+
+static FAutoConsoleCommandWithWorld CombatInputBufferDelayResetCommand(
+	TEXT("Combat.InputBufferDelay.Reset"),
+	TEXT("Clears the player's input buffer delay histograms."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (const auto Player = GetBufferDelayPlayer(World))
+		{
+			Player->GetInputBufferDelay().Reset();
+		}
+	}));
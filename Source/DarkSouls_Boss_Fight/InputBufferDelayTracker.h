@@ -0,0 +1,47 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+enum class EBufferedAction : uint8
+{
+	Attack,
+	Roll,
+
+	Count
+};
+
+/**
+ * Input buffer delay histograms, one per buffered action: how long a press waited
+ * between its input binding running and the Attack/Roll call that starts its montage.
+ * A press acted on right away records ~0 ms. This is not end-to-end input latency,
+ * device, frame, anim tick and display delay are not part of it.
+ * Dump with Combat.InputBufferDelay, export with Combat.InputBufferDelay.Export [File].
+ */
+class DARKSOULS_BOSS_FIGHT_API FInputBufferDelayTracker
+{
+public:
+	// upper bucket bounds in milliseconds, the last bucket catches everything above
+	static constexpr int32 NumBuckets = 9;
+	static const float BucketUpperBoundsMs[NumBuckets - 1];
+
+	void Record(EBufferedAction Action, double DelayMs);
+	void Reset();
+
+	void DumpToLog() const;
+	bool ExportCsv(const FString& FilePath) const;
+
+	static const TCHAR* GetActionName(EBufferedAction Action);
+
+private:
+	struct FHistogram
+	{
+		int32 Buckets[NumBuckets] = {};
+		int32 Count = 0;
+		double SumMs = 0.;
+		double MaxMs = 0.;
+	};
+
+	FHistogram Histograms[static_cast<int32>(EBufferedAction::Count)];
+};
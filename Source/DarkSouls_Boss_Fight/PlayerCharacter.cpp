@@ -69,6 +69,12 @@ APlayerCharacter::APlayerCharacter()
 // Called when the game starts or when spawned
 void APlayerCharacter::BeginPlay()
 {
+	// CameraShakeMinor predates HitFeedback, keep it as the default hit shake
+	if (!HitFeedback.CameraShake)
+	{
+		HitFeedback.CameraShake = CameraShakeMinor;
+	}
+
 	Super::BeginPlay();
 
 	EnemyDetectionCollider->OnComponentBeginOverlap.
@@ -91,6 +97,7 @@ void APlayerCharacter::BeginPlay()
 void APlayerCharacter::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
+	ReplayBufferedInput();
 	FocusTarget();//should we toggle of combat mode
 	if (bRolling)
 	{
@@ -113,8 +120,7 @@ void APlayerCharacter::Tick(float DeltaTime)
 				if (AppliedDamage > 0.f)
 				{
 					AttackHitActors.Add(HitActor);
-					GetWorld()->GetFirstPlayerController()->
-						PlayerCameraManager->StartCameraShake(CameraShakeMinor);
+					PushCombatEvent(ECombatEventType::HitLanded, HitActor, AppliedDamage);
 				}
 			}
 		}
@@ -152,9 +158,9 @@ void APlayerCharacter::SetupPlayerInputComponent(UInputComponent* PlayerInputCom
 	PlayerInputComponent->BindAction("CombatModeToggle", IE_Pressed, this,
 		&APlayerCharacter::ToggleCombatMode);
 	PlayerInputComponent->BindAction("Attack", IE_Pressed, this,
-		&APlayerCharacter::Attack);
+		&APlayerCharacter::OnAttackPressed);
 	PlayerInputComponent->BindAction("Roll", IE_Pressed, this,
-		&APlayerCharacter::Roll);
+		&APlayerCharacter::OnRollPressed);
 	PlayerInputComponent->BindAction("CycleTarget+", IE_Pressed, this,
 		&APlayerCharacter::CycleTargetClockwise);
 	PlayerInputComponent->BindAction("CycleTarget-", IE_Pressed, this,
@@ -252,11 +258,19 @@ void APlayerCharacter::CycleTargetCounterClockwise()
 	CycleTarget(false);
 }
 
-void APlayerCharacter::LookAtSmooth()
+void APlayerCharacter::GatherSnapshot(FCombatantSnapshot& Snapshot) const
 {
-	if (!bRolling)
+	Super::GatherSnapshot(Snapshot);
+	Snapshot.bCanRotate = Snapshot.bCanRotate && !bRolling;
+}
+
+void APlayerCharacter::GetWarmupMontages(TArray<UAnimMontage*>& OutMontages) const
+{
+	Super::GetWarmupMontages(OutMontages);
+	OutMontages.Append(Attacks);
+	if (CombatRoll)
 	{
-		Super::LookAtSmooth();
+		OutMontages.Add(CombatRoll);
 	}
 }
 
@@ -277,6 +291,7 @@ float APlayerCharacter::TakeDamage(float DamageAmount, FDamageEvent const& Damag
 
 	PlayAnimMontage(TakeHit_StumbleBackwards[AnimationIndex]);
 	LastStumbleIndex = AnimationIndex;
+	PushCombatEvent(ECombatEventType::StumbleStarted, DamageCauser, DamageAmount);
 
 	auto Direction = DamageCauser->GetActorLocation() - GetActorLocation();
 	Direction.Z = 0.f;
@@ -302,10 +317,121 @@ void APlayerCharacter::OnEnemyDetectionEndOverlap(UPrimitiveComponent* Overlappe
 	}
 }
 
+void APlayerCharacter::OnAttackPressed()
+{
+	BufferInput(EBufferedAction::Attack);
+}
+
+void APlayerCharacter::OnRollPressed()
+{
+	BufferInput(EBufferedAction::Roll);
+}
+
+void APlayerCharacter::BufferInput(EBufferedAction Action)
+{
+	const auto PressedPlatformTime = FPlatformTime::Seconds();
+
+	// a new press always gets its chance right away, whatever is still queued was
+	// pressed before it and is superseded
+	if (TryPerformAction(Action, PressedPlatformTime))
+	{
+		RemoveBufferedInputs(InputBufferCount);
+		return;
+	}
+
+	// a roll is the more urgent intent, queued attacks must not hold it back
+	if (Action == EBufferedAction::Roll)
+	{
+		int32 Kept = 0;
+		for (int32 Index = 0; Index < InputBufferCount; ++Index)
+		{
+			if (InputBuffer[Index].Action != EBufferedAction::Attack)
+			{
+				InputBuffer[Kept++] = InputBuffer[Index];
+			}
+		}
+		InputBufferCount = Kept;
+	}
+
+	// full: the oldest press gives way to the newest
+	if (InputBufferCount == InputBufferCapacity)
+	{
+		RemoveBufferedInputs(1);
+	}
+
+	auto& Input = InputBuffer[InputBufferCount++];
+	Input.Action = Action;
+	Input.PressedTime = GetWorld()->GetTimeSeconds();
+	Input.PressedPlatformTime = PressedPlatformTime;
+}
+
+void APlayerCharacter::ReplayBufferedInput()
+{
+	const auto Now = GetWorld()->GetTimeSeconds();
+	int32 Expired = 0;
+	while (Expired < InputBufferCount && Now - InputBuffer[Expired].PressedTime > InputBufferWindow)
+	{
+		++Expired;
+	}
+	RemoveBufferedInputs(Expired);
+
+	// a blocked press doesn't hold back a later one that is allowed, and once one runs the
+	// presses queued before it are superseded
+	for (int32 Index = 0; Index < InputBufferCount; ++Index)
+	{
+		if (TryPerformAction(InputBuffer[Index].Action, InputBuffer[Index].PressedPlatformTime))
+		{
+			RemoveBufferedInputs(Index + 1);
+			return;
+		}
+	}
+}
+
+void APlayerCharacter::RemoveBufferedInputs(int32 Count)
+{
+	Count = FMath::Min(Count, InputBufferCount);
+	for (int32 Index = Count; Index < InputBufferCount; ++Index)
+	{
+		InputBuffer[Index - Count] = InputBuffer[Index];
+	}
+	InputBufferCount -= Count;
+}
+
+bool APlayerCharacter::TryPerformAction(EBufferedAction Action, double PressedPlatformTime)
+{
+	switch (Action)
+	{
+	case EBufferedAction::Attack:
+		if (!CanAttack()) return false;
+		Attack();
+		break;
+	case EBufferedAction::Roll:
+		if (!CanRoll()) return false;
+		Roll();
+		break;
+	default:
+		return false;
+	}
+
+	// time the press spent waiting for Attack/Roll to accept it
+	InputBufferDelay.Record(Action, (FPlatformTime::Seconds() - PressedPlatformTime) * 1000.);
+	return true;
+}
+
+bool APlayerCharacter::CanAttack() const
+{
+	return (!bAttacking || bNextAttackReady) && !bRolling && !bStumbling &&
+		!GetCharacterMovement()->IsFalling();
+}
+
+bool APlayerCharacter::CanRoll() const
+{
+	return !bRolling && !bStumbling;
+}
+
 void APlayerCharacter::Attack()
 {
-	if ((!bAttacking || bNextAttackReady) && !bRolling && !bStumbling &&
-		!GetCharacterMovement()->IsFalling())
+	if (CanAttack())
 	{
 		Super::Attack();
 
@@ -322,7 +448,7 @@ void APlayerCharacter::EndAttack()
 
 void APlayerCharacter::Roll()
 {
-	if (bRolling || bStumbling) return;
+	if (!CanRoll()) return;
 	//! TODO Maybe add SetAttackDamaging(false); ?
 	EndAttack();
 	if (!InputDirection.IsZero())
@@ -342,6 +468,7 @@ void APlayerCharacter::Roll()
 	SetActorRotation(RollRotation);
 	PlayAnimMontage(CombatRoll);
 	bRolling = true;
+	PushCombatEvent(ECombatEventType::RollStarted);
 }
 
 void APlayerCharacter::StartRoll()
@@ -354,6 +481,7 @@ void APlayerCharacter::StartRoll()
 void APlayerCharacter::EndRoll()
 {
 	bRolling = false;
+	PushCombatEvent(ECombatEventType::RollEnded);
 	GetCharacterMovement()->MaxWalkSpeed = bTargetLocked ? CombatMovementSpeed : PassiveMovementSpeed;
 }
 
@@ -5,6 +5,7 @@
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
 #include "Combatant.h"
+#include "InputBufferDelayTracker.h"
 #include "PlayerCharacter.generated.h"
 
 class ULegacyCameraShake;
@@ -60,7 +61,9 @@ public:
 	UFUNCTION()
 		void CycleTargetCounterClockwise();
 
-	virtual void LookAtSmooth() override;
+	virtual void GatherSnapshot(FCombatantSnapshot& Snapshot) const override;
+
+	virtual void GetWarmupMontages(TArray<UAnimMontage*>& OutMontages) const override;
 
 	float TakeDamage(float DamageAmount, FDamageEvent const& DamageEvent,
 		AController* EventInstigator, AActor* DamageCauser);
@@ -74,6 +77,10 @@ public:
 	UPROPERTY(EditAnywhere, Category = Camera)
 		TSubclassOf<ULegacyCameraShake> CameraShakeMinor;
 
+	// how long an attack or roll press is kept while the character can't act on it
+	UPROPERTY(EditAnywhere, Category = "Input")
+		float InputBufferWindow = .3f;
+
 	bool bRolling = false;
 	FRotator RollRotation;
 
@@ -105,6 +112,23 @@ protected:
 
 	void Roll();
 
+	bool CanAttack() const;
+	bool CanRoll() const;
+
+	void OnAttackPressed();
+	void OnRollPressed();
+
+	// act on a press right away, or queue it to be replayed once the action is allowed
+	void BufferInput(EBufferedAction Action);
+
+	// drop expired presses and run the oldest one that is allowed, at most one per frame
+	void ReplayBufferedInput();
+
+	// forget the first Count buffered presses
+	void RemoveBufferedInputs(int32 Count);
+
+	bool TryPerformAction(EBufferedAction Action, double PressedPlatformTime);
+
 	UFUNCTION(BlueprintCallable, Category = "Combat")
 		void StartRoll();
 
@@ -136,7 +160,26 @@ public:
 		return Weapon;
 	}
 
+	FInputBufferDelayTracker& GetInputBufferDelay()
+	{
+		return InputBufferDelay;
+	}
+
 private:
 	float RollingDistance = 600.f;
 	float MovingBackwardsDistance = 40.f;
+
+	struct FBufferedInput
+	{
+		EBufferedAction Action = EBufferedAction::Attack;
+		float PressedTime = 0.f;			// world time, for the buffer window
+		double PressedPlatformTime = 0.;	// wall clock, for the buffer delay stats
+	};
+
+	// oldest press first
+	static constexpr int32 InputBufferCapacity = 4;
+	FBufferedInput InputBuffer[InputBufferCapacity];
+	int32 InputBufferCount = 0;
+
+	FInputBufferDelayTracker InputBufferDelay;
 };